@@ -1,10 +1,12 @@
 #include "util/https_download.h"
-#include "util/extract_tar_gz.h"
+#include "util/log.h"
+#include "util/provision.h"
 #include <nlohmann/json.hpp>
+#include <algorithm>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
-#include <iostream>
+#include <set>
 #include <sstream>
 #include <string>
 #include <unistd.h>
@@ -14,14 +16,6 @@
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
-// -------------------------------------------------------------------
-// Logging
-// -------------------------------------------------------------------
-static void log(const std::string &msg) {
-    std::cerr << msg << std::endl;
-    std::cerr.flush();
-}
-
 // -------------------------------------------------------------------
 // Fork/exec wrapper
 // -------------------------------------------------------------------
@@ -114,28 +108,35 @@ static std::string pick_channel_url(const json &index, int pinnedMajor = -1) {
     return {};
 }
 
+// -------------------------------------------------------------------
+// Pick the tar.gz for a rid from a release "files" list
+// -------------------------------------------------------------------
+static std::string pick_file(const json &files, const std::string &label,
+                             const std::string &rid = "linux-x64") {
+    for (auto &f : files) {
+        std::string fRid = f.value("rid", "");
+        std::string fUrl = f.value("url", "");
+        std::string fName = f.value("name", "");
+        std::string fType = f.value("file-type", "");
+        // ASP.NET Core also ships a "composite" tarball for the same rid
+        if (fName.find("composite") != std::string::npos)
+            continue;
+        if (fRid == rid && !fUrl.empty()) {
+            if (fType == "installer" || fName.find(".tar.gz") != std::string::npos) {
+                log("Selected " + label + " asset: " + fName);
+                return fUrl;
+            }
+        }
+    }
+    return {};
+}
+
 // -------------------------------------------------------------------
 // Pick Hosting Bundle runtime asset (default) or SDK
 // -------------------------------------------------------------------
 static std::string pick_asset_url(const json &channel,
                                   const std::string &targetVersion,
                                   const std::string &rid = "linux-x64") {
-    auto pickFile = [&](const json &files, const std::string &label) -> std::string {
-        for (auto &f : files) {
-            std::string fRid = f.value("rid", "");
-            std::string fUrl = f.value("url", "");
-            std::string fName = f.value("name", "");
-            std::string fType = f.value("file-type", "");
-            if (fRid == rid && !fUrl.empty()) {
-                if (fType == "installer" || fName.find(".tar.gz") != std::string::npos) {
-                    log("Selected " + label + " asset: " + fName);
-                    return fUrl;
-                }
-            }
-        }
-        return {};
-    };
-
     for (auto &release : channel["releases"]) {
         std::string ver = release.value("release-version", "");
         if (ver != targetVersion)
@@ -143,13 +144,13 @@ static std::string pick_asset_url(const json &channel,
 
 
         if (release.contains("sdk") && release["sdk"].contains("files")) {
-            std::string url = pickFile(release["sdk"]["files"], "SDK");
+            std::string url = pick_file(release["sdk"]["files"], "SDK", rid);
             if (!url.empty())
                 return url;
         }
 
         if (release.contains("runtime") && release["runtime"].contains("files")) {
-            std::string url = pickFile(release["runtime"]["files"], "runtime");
+            std::string url = pick_file(release["runtime"]["files"], "runtime", rid);
             if (!url.empty())
                 return url;
         }
@@ -159,6 +160,482 @@ static std::string pick_asset_url(const json &channel,
     return {};
 }
 
+// -------------------------------------------------------------------
+// Archive + extract locations for a download URL in the shared store
+// -------------------------------------------------------------------
+static Component make_component(const std::string &url,
+                                const std::string &label,
+                                const std::string &version,
+                                const fs::path &archivesDir,
+                                const fs::path &versionsDir) {
+    Component c;
+    c.label = label;
+    split_url(url, c.host, c.path);
+    c.archivePath = archivesDir / fs::path(c.path).filename();
+    std::string baseName = fs::path(c.path).stem().stem().string();
+    c.extractDir = versionsDir / (version + "-" + baseName);
+    return c;
+}
+
+// -------------------------------------------------------------------
+// Find releases.json URL for a given major (LTS or STS)
+// -------------------------------------------------------------------
+static std::string find_channel_url(const json &index, int wantedMajor) {
+    for (auto &entry : index["releases-index"]) {
+        std::string chanVer = entry.value("channel-version", "");
+        std::string url = entry.value("releases.json", "");
+        if (url.empty())
+            continue;
+        try {
+            int major = std::stoi(chanVer.substr(0, chanVer.find('.')));
+            if (major == wantedMajor)
+                return url;
+        } catch (...) {
+        }
+    }
+    return {};
+}
+
+// -------------------------------------------------------------------
+// SDK version "X.Y.ZNN[-pre]"; the feature band is Z (ZNN / 100)
+// -------------------------------------------------------------------
+// SemVer prerelease order: dot-separated identifiers, numeric ones
+// compared as numbers and sorting before alphanumeric ones
+static bool prerelease_less(const std::string &a, const std::string &b) {
+    std::istringstream ia(a), ib(b);
+    std::string pa, pb;
+    while (true) {
+        bool moreA = static_cast<bool>(std::getline(ia, pa, '.'));
+        bool moreB = static_cast<bool>(std::getline(ib, pb, '.'));
+        if (!moreA || !moreB)
+            return !moreA && moreB;  // fewer identifiers sorts first
+        if (pa == pb)
+            continue;
+
+        bool numA = !pa.empty() && std::all_of(pa.begin(), pa.end(), ::isdigit);
+        bool numB = !pb.empty() && std::all_of(pb.begin(), pb.end(), ::isdigit);
+        if (numA && numB)
+            return pa.size() != pb.size() ? pa.size() < pb.size() : pa < pb;
+        if (numA != numB)
+            return numA;
+        return pa < pb;
+    }
+}
+
+struct SdkVersion {
+    int major = 0, minor = 0, patch = 0;
+    std::string pre;
+
+    bool operator<(const SdkVersion &o) const {
+        if (major != o.major) return major < o.major;
+        if (minor != o.minor) return minor < o.minor;
+        if (patch != o.patch) return patch < o.patch;
+        if (pre.empty() != o.pre.empty()) return !pre.empty();  // prerelease sorts first
+        return prerelease_less(pre, o.pre);
+    }
+};
+
+static bool parse_sdk_version(const std::string &text, SdkVersion &v) {
+    std::string core = text.substr(0, text.find('-'));
+    v.pre = core.size() < text.size() ? text.substr(core.size() + 1) : "";
+    char dot1 = 0, dot2 = 0;
+    std::istringstream in(core);
+    in >> v.major >> dot1 >> v.minor >> dot2 >> v.patch;
+    return in && dot1 == '.' && dot2 == '.' && in.peek() == EOF;
+}
+
+// -------------------------------------------------------------------
+// Pick SDK asset for a global.json version, following the dotnet
+// rollForward rules within the requested major.minor channel:
+//   disable          exact version only
+//   patch            exact, else latest patch in the same feature band
+//   feature/minor/   exact, else latest patch in the same feature band,
+//   major            else latest patch in the next higher feature band
+//   latest*          newest version >= requested in the policy's scope
+// -------------------------------------------------------------------
+static std::string pick_sdk_url(const json &channel, std::string &sdkVersion,
+                                const std::string &rollForward, bool allowPrerelease) {
+    SdkVersion wanted;
+    if (!parse_sdk_version(sdkVersion, wanted)) {
+        log("SDK version " + sdkVersion + " is not of the form X.Y.ZNN");
+        return {};
+    }
+
+    struct Candidate {
+        SdkVersion version;
+        std::string text;
+        json files;
+    };
+
+    // Everything >= requested in this major.minor that prerelease rules allow
+    std::vector<Candidate> candidates;
+    for (auto &release : channel["releases"]) {
+        json sdks = release.value("sdks", json::array());
+        if (sdks.empty() && release.contains("sdk"))
+            sdks.push_back(release["sdk"]);
+        for (auto &sdk : sdks) {
+            std::string text = sdk.value("version", "");
+            SdkVersion v;
+            if (!sdk.contains("files") || !parse_sdk_version(text, v))
+                continue;
+            if (v.major != wanted.major || v.minor != wanted.minor || v < wanted)
+                continue;
+            if (text != sdkVersion && !v.pre.empty() && !allowPrerelease)
+                continue;
+            candidates.push_back({v, text, sdk["files"]});
+        }
+    }
+
+    auto band = [](const SdkVersion &v) { return v.patch / 100; };
+    auto newestIn = [&](int featureBand) -> const Candidate * {
+        const Candidate *best = nullptr;
+        for (auto &c : candidates) {
+            if (featureBand != -1 && band(c.version) != featureBand)
+                continue;
+            if (!best || best->version < c.version)
+                best = &c;
+        }
+        return best;
+    };
+
+    const Candidate *pick = nullptr;
+    bool latest = rollForward.rfind("latest", 0) == 0;
+    if (!latest) {
+        for (auto &c : candidates) {
+            if (c.text == sdkVersion)
+                pick = &c;
+        }
+    }
+
+    if (pick || rollForward == "disable") {
+        // exact match, or nothing else allowed
+    } else if (rollForward == "patch" || rollForward == "latestPatch") {
+        pick = newestIn(band(wanted));
+    } else if (latest) {
+        pick = newestIn(-1);
+    } else {
+        pick = newestIn(band(wanted));
+        if (!pick) {
+            int nextBand = -1;
+            for (auto &c : candidates) {
+                if (nextBand == -1 || band(c.version) < nextBand)
+                    nextBand = band(c.version);
+            }
+            if (nextBand != -1)
+                pick = newestIn(nextBand);
+        }
+    }
+
+    if (!pick) {
+        log("No SDK satisfies " + sdkVersion + " (rollForward=" + rollForward +
+            ", feature band " + std::to_string(wanted.major) + "." +
+            std::to_string(wanted.minor) + "." + std::to_string(band(wanted)) + "xx)");
+        return {};
+    }
+    if (pick->text != sdkVersion)
+        log("SDK " + sdkVersion + " rolled forward to " + pick->text);
+    sdkVersion = pick->text;
+    return pick_file(pick->files, "SDK " + pick->text);
+}
+
+// -------------------------------------------------------------------
+// Pick shared framework asset from release[key] ("runtime" or
+// "aspnetcore-runtime"); "X" / "X.Y" resolve to the newest release
+// -------------------------------------------------------------------
+static std::string pick_runtime_url(const json &channel, const std::string &key,
+                                    const std::string &label, std::string &runtimeVersion) {
+    bool exact = std::count(runtimeVersion.begin(), runtimeVersion.end(), '.') >= 2;
+
+    // releases.json lists the newest release first
+    for (auto &release : channel["releases"]) {
+        if (!release.contains(key) || !release[key].is_object())
+            continue;
+        auto &runtime = release[key];
+        std::string ver = runtime.value("version", "");
+        bool match = exact ? ver == runtimeVersion : ver.rfind(runtimeVersion + ".", 0) == 0;
+        if (!match || !runtime.contains("files"))
+            continue;
+
+        if (ver != runtimeVersion)
+            log("Resolved " + label + " " + runtimeVersion + " to latest " + ver);
+        runtimeVersion = ver;
+        return pick_file(runtime["files"], label + " " + ver);
+    }
+
+    log("pick_runtime_url: No matching asset found for " + label + " " + runtimeVersion);
+    return {};
+}
+
+// -------------------------------------------------------------------
+// Major of an "X[.Y[.Z]]" version string, -1 if it does not start with one
+// -------------------------------------------------------------------
+static int version_major(const std::string &version) {
+    if (version.empty() || !isdigit(static_cast<unsigned char>(version[0])))
+        return -1;
+    try {
+        return std::stoi(version);
+    } catch (...) {
+        return -1;
+    }
+}
+
+// -------------------------------------------------------------------
+// Default resolution: pinned version, else version.txt major, else the
+// active LTS. Returns the asset URL and sets targetVersion.
+// -------------------------------------------------------------------
+static std::string resolve_default_asset(const json &index,
+                                         std::string pinnedVersion,
+                                         const fs::path &versionFile,
+                                         std::string &targetVersion) {
+    json channelJson;
+
+    if (!pinnedVersion.empty()) {
+        std::string majorStr = pinnedVersion.substr(0, pinnedVersion.find('.'));
+        int pinnedMajor = std::stoi(majorStr);
+
+        std::string pinnedChannelUrl = find_channel_url(index, pinnedMajor);
+        if (pinnedChannelUrl.empty()) {
+            log("No channel found for major " + majorStr);
+            return {};
+        }
+
+        std::string host, path;
+        split_url(pinnedChannelUrl, host, path);
+        std::string channelStr = https_get_string(host, path);
+        channelJson = json::parse(channelStr);
+
+        if (pinnedVersion.find('.') == std::string::npos) {
+            pinnedVersion = channelJson.value("latest-release", "");
+            log("Resolved major " + majorStr + " to latest " + pinnedVersion);
+        } else if (std::count(pinnedVersion.begin(), pinnedVersion.end(), '.') == 1) {
+            std::string best;
+            for (auto &release : channelJson["releases"]) {
+                std::string relVer = release.value("release-version", "");
+                if (relVer.rfind(pinnedVersion + ".", 0) == 0) {
+                    if (best.empty() || relVer > best)
+                        best = relVer;
+                }
+            }
+            if (!best.empty()) {
+                pinnedVersion = best;
+                log("Resolved " + pinnedVersion + ".* to " + best);
+            }
+        }
+        targetVersion = pinnedVersion;
+
+        // -- Write pinned major to version.txt (overwrite old pin)
+        try {
+            int pinnedMajorInt = std::stoi(pinnedVersion.substr(0, pinnedVersion.find('.')));
+            std::ofstream fout(versionFile, std::ios::trunc);
+            fout << pinnedMajorInt;
+            log("Pinned major " + std::to_string(pinnedMajorInt) + " written into version.txt");
+        } catch (...) {
+            log("Warning: could not parse pinned major from " + pinnedVersion);
+        }
+    } else {
+        int cachedMajor = -1;
+        if (fs::exists(versionFile)) {
+            std::ifstream fin(versionFile);
+            fin >> cachedMajor;
+        }
+
+        std::string channelUrl;
+        if (cachedMajor != -1) {
+            // ---- Direct lookup for cachedMajor, allow STS too
+            channelUrl = find_channel_url(index, cachedMajor);
+            if (channelUrl.empty()) {
+                log("No channel found for pinned major " + std::to_string(cachedMajor));
+                return {};
+            }
+        } else {
+            // ---- First-time run, no version.txt yet → pick active LTS
+            channelUrl = pick_channel_url(index);
+            if (channelUrl.empty()) {
+                log("Could not determine channel URL");
+                return {};
+            }
+        }
+
+        std::string host, path;
+        split_url(channelUrl, host, path);
+        std::string channelStr = https_get_string(host, path);
+        channelJson = json::parse(channelStr);
+
+        targetVersion = channelJson.value("latest-release", "");
+        if (cachedMajor == -1) {
+            try {
+                int latestMajor = std::stoi(channelJson.value("channel-version", "0"));
+                std::ofstream fout(versionFile);
+                fout << latestMajor;
+                log("Pinned major " + std::to_string(latestMajor) + " into version.txt");
+            } catch (...) {
+            }
+        }
+    }
+
+    std::string downloadUrl = pick_asset_url(channelJson, targetVersion);
+    if (downloadUrl.empty())
+        log("No asset found for version " + targetVersion);
+    return downloadUrl;
+}
+
+// -------------------------------------------------------------------
+// Manifest mode: SDK from global.json plus extra shared runtimes
+//
+// {
+//   "sdk": { "version": "9.0.100", "rollForward": "latestPatch" },
+//   "run-dotnet": { "runtimes": [ "8.0", "9" ], "aspnetcore": [ "8.0" ] }
+// }
+//
+// "runtimes" adds Microsoft.NETCore.App, "aspnetcore" adds
+// Microsoft.AspNetCore.App (which also brings its matching NETCore.App).
+// Without "sdk.version" the SDK is chosen as in plain mode.
+// -------------------------------------------------------------------
+struct Manifest {
+    std::string sdkVersion;
+    std::string rollForward = "latestPatch";
+    bool allowPrerelease = false;
+    std::vector<std::string> runtimes;
+    std::vector<std::string> aspnetcore;
+};
+
+static bool read_manifest(const fs::path &globalJson, Manifest &m) {
+    std::ifstream fin(globalJson);
+    json manifest;
+    try {
+        manifest = json::parse(fin, nullptr, true, true);
+    } catch (const json::parse_error &e) {
+        throw std::runtime_error("global.json: " + std::string(e.what()));
+    }
+
+    auto invalid = [](const std::string &key, const json &value, const std::string &expected) {
+        return std::runtime_error("global.json: " + key + " must be " + expected +
+                                  ", got " + value.dump());
+    };
+    auto versionOf = [&](const std::string &key, const json &value) -> std::string {
+        if (!value.is_string() || version_major(value.get<std::string>()) == -1)
+            throw invalid(key, value, "a version string like \"8.0\"");
+        return value.get<std::string>();
+    };
+
+    if (manifest.contains("sdk")) {
+        auto &sdk = manifest["sdk"];
+        if (!sdk.is_object())
+            throw invalid("sdk", sdk, "an object");
+        if (sdk.contains("version"))
+            m.sdkVersion = versionOf("sdk.version", sdk["version"]);
+        if (sdk.contains("rollForward")) {
+            static const std::set<std::string> policies = {
+                "disable", "patch", "feature", "minor", "major",
+                "latestPatch", "latestFeature", "latestMinor", "latestMajor"};
+            auto &policy = sdk["rollForward"];
+            if (!policy.is_string() || !policies.count(policy.get<std::string>()))
+                throw invalid("sdk.rollForward", policy, "a dotnet rollForward policy");
+            m.rollForward = policy.get<std::string>();
+        }
+        if (sdk.contains("allowPrerelease")) {
+            auto &pre = sdk["allowPrerelease"];
+            if (!pre.is_boolean())
+                throw invalid("sdk.allowPrerelease", pre, "true or false");
+            m.allowPrerelease = pre.get<bool>();
+        }
+    }
+
+    if (manifest.contains("run-dotnet")) {
+        auto &extra = manifest["run-dotnet"];
+        if (!extra.is_object())
+            throw invalid("run-dotnet", extra, "an object");
+        auto readList = [&](const std::string &name, std::vector<std::string> &out) {
+            if (!extra.contains(name))
+                return;
+            auto &list = extra[name];
+            std::string key = "run-dotnet." + name;
+            if (!list.is_array())
+                throw invalid(key, list, "an array");
+            for (size_t i = 0; i < list.size(); ++i)
+                out.push_back(versionOf(key + "[" + std::to_string(i) + "]", list[i]));
+        };
+        readList("runtimes", m.runtimes);
+        readList("aspnetcore", m.aspnetcore);
+    }
+    return !m.sdkVersion.empty() || !m.runtimes.empty() || !m.aspnetcore.empty();
+}
+
+// Resolves every component, then downloads and extracts them all on one
+// pool so total time tracks the largest component rather than the sum.
+static bool provision_manifest(const json &index,
+                               const Manifest &manifest,
+                               std::vector<Component> components,
+                               const fs::path &archivesDir,
+                               const fs::path &versionsDir,
+                               std::vector<fs::path> &extractDirs) {
+    struct Request {
+        std::string key;    // releases.json component: "sdk", "runtime", "aspnetcore-runtime"
+        std::string label;
+        std::string version;
+        int major;
+    };
+
+    std::vector<Request> requests;
+    if (!manifest.sdkVersion.empty())
+        requests.push_back({"sdk", "SDK", manifest.sdkVersion, version_major(manifest.sdkVersion)});
+    for (auto &r : manifest.runtimes)
+        requests.push_back({"runtime", "runtime", r, version_major(r)});
+    for (auto &r : manifest.aspnetcore)
+        requests.push_back({"aspnetcore-runtime", "ASP.NET Core runtime", r, version_major(r)});
+
+    // ---- Fetch each distinct channel once, concurrently
+    std::vector<int> majors;
+    for (auto &req : requests) {
+        if (std::find(majors.begin(), majors.end(), req.major) == majors.end())
+            majors.push_back(req.major);
+    }
+
+    std::vector<json> channels(majors.size());
+    auto errors = run_parallel(majors.size(), [&](size_t i) {
+        std::string channelUrl = find_channel_url(index, majors[i]);
+        if (channelUrl.empty())
+            throw std::runtime_error("No channel found for major " + std::to_string(majors[i]));
+
+        std::string host, path;
+        split_url(channelUrl, host, path);
+        channels[i] = json::parse(https_get_string(host, path));
+    });
+    if (!errors.empty()) {
+        for (auto &e : errors)
+            log("Error: " + e);
+        return false;
+    }
+
+    // ---- Resolve every request to one archive, after any preselected SDK
+    std::set<fs::path> seenArchives;
+    for (auto &c : components)
+        seenArchives.insert(c.archivePath);
+    for (auto &req : requests) {
+        size_t idx = std::find(majors.begin(), majors.end(), req.major) - majors.begin();
+        std::string version = req.version;
+        std::string url = req.key == "sdk"
+            ? pick_sdk_url(channels[idx], version, manifest.rollForward, manifest.allowPrerelease)
+            : pick_runtime_url(channels[idx], req.key, req.label, version);
+        std::string label = req.label + " " + version;
+        if (url.empty()) {
+            log("No asset found for " + label);
+            return false;
+        }
+        Component c = make_component(url, label, version, archivesDir, versionsDir);
+        if (seenArchives.insert(c.archivePath).second)
+            components.push_back(c);
+    }
+
+    if (!provision_components(components))
+        return false;
+
+    // SDK first so its dotnet host and shared files win the merge
+    for (auto &c : components)
+        extractDirs.push_back(c.extractDir);
+    return true;
+}
+
 // -------------------------------------------------------------------
 // Main
 // -------------------------------------------------------------------
@@ -189,150 +666,44 @@ int main(int argc, char *argv[]) {
             }
         }
 
+        Manifest manifest;
+        fs::path globalJson = projectRoot / "global.json";
+        bool manifestMode = pinnedVersion.empty() && fs::exists(globalJson) &&
+                            read_manifest(globalJson, manifest);
+
         std::string idxStr = https_get_string(
             "dotnetcli.blob.core.windows.net",
             "/dotnet/release-metadata/releases-index.json");
         json index = json::parse(idxStr);
 
-        std::string targetVersion;
-        json channelJson;
-
-        if (!pinnedVersion.empty()) {
-            std::string majorStr = pinnedVersion.substr(0, pinnedVersion.find('.'));
-            int pinnedMajor = std::stoi(majorStr);
-
-            std::string pinnedChannelUrl;
-            for (auto &entry : index["releases-index"]) {
-                std::string chanVer = entry.value("channel-version", "");
-                std::string url = entry.value("releases.json", "");
-                if (url.empty())
-                    continue;
-
-                try {
-                    int major = std::stoi(chanVer.substr(0, chanVer.find('.')));
-                    if (major == pinnedMajor) {
-                        pinnedChannelUrl = url;
-                        break;
-                    }
-                } catch (...) {
-                }
-            }
-
-            if (pinnedChannelUrl.empty()) {
-                log("No channel found for major " + majorStr);
-                return 1;
-            }
-
-            std::string host, path;
-            split_url(pinnedChannelUrl, host, path);
-            std::string channelStr = https_get_string(host, path);
-            channelJson = json::parse(channelStr);
-
-            if (pinnedVersion.find('.') == std::string::npos) {
-                pinnedVersion = channelJson.value("latest-release", "");
-                log("Resolved major " + majorStr + " to latest " + pinnedVersion);
-            } else if (std::count(pinnedVersion.begin(), pinnedVersion.end(), '.') == 1) {
-                std::string best;
-                for (auto &release : channelJson["releases"]) {
-                    std::string relVer = release.value("release-version", "");
-                    if (relVer.rfind(pinnedVersion + ".", 0) == 0) {
-                        if (best.empty() || relVer > best)
-                            best = relVer;
-                    }
-                }
-                if (!best.empty()) {
-                    pinnedVersion = best;
-                    log("Resolved " + pinnedVersion + ".* to " + best);
-                }
-            }
-            targetVersion = pinnedVersion;
-
-            // -- Write pinned major to version.txt (overwrite old pin)
-            try {
-                int pinnedMajorInt = std::stoi(pinnedVersion.substr(0, pinnedVersion.find('.')));
-                std::ofstream fout(versionFile, std::ios::trunc);
-                fout << pinnedMajorInt;
-                log("Pinned major " + std::to_string(pinnedMajorInt) + " written into version.txt");
-            } catch (...) {
-                log("Warning: could not parse pinned major from " + pinnedVersion);
-            }
-        } else {
-            int cachedMajor = -1;
-            if (fs::exists(versionFile)) {
-                std::ifstream fin(versionFile);
-                fin >> cachedMajor;
-            }
-
-        std::string channelUrl;
-        if (cachedMajor != -1) {
-            // ---- Direct lookup for cachedMajor, allow STS too
-            for (auto &entry : index["releases-index"]) {
-                std::string chanVer = entry.value("channel-version", "");
-                std::string url = entry.value("releases.json", "");
-                if (url.empty()) continue;
-                try {
-                    int major = std::stoi(chanVer.substr(0, chanVer.find('.')));
-                    if (major == cachedMajor) {
-                        channelUrl = url;
-                        break;
-                    }
-                } catch (...) {}
+        std::vector<fs::path> extractDirs;
+        if (manifestMode) {
+            log("Provisioning from global.json");
+            std::vector<Component> base;
+            if (manifest.sdkVersion.empty()) {
+                // No sdk.version: same SDK as plain mode, extra runtimes next to it
+                std::string targetVersion;
+                std::string sdkUrl = resolve_default_asset(index, "", versionFile, targetVersion);
+                if (sdkUrl.empty())
+                    return 1;
+                base.push_back(make_component(sdkUrl, "SDK " + targetVersion, targetVersion,
+                                              archivesDir, versionsDir));
             }
-            if (channelUrl.empty()) {
-                log("No channel found for pinned major " + std::to_string(cachedMajor));
+            if (!provision_manifest(index, manifest, base, archivesDir, versionsDir, extractDirs)) {
                 return 1;
             }
         } else {
-            // ---- First-time run, no version.txt yet → pick active LTS
-            channelUrl = pick_channel_url(index);
-            if (channelUrl.empty()) {
-                log("Could not determine channel URL");
+            std::string targetVersion;
+            std::string downloadUrl = resolve_default_asset(index, pinnedVersion, versionFile,
+                                                            targetVersion);
+            if (downloadUrl.empty())
                 return 1;
-            }
-        }
 
-            std::string host, path;
-            split_url(channelUrl, host, path);
-            std::string channelStr = https_get_string(host, path);
-            channelJson = json::parse(channelStr);
-
-            targetVersion = channelJson.value("latest-release", "");
-            if (cachedMajor == -1) {
-                try {
-                    int latestMajor = std::stoi(channelJson.value("channel-version", "0"));
-                    std::ofstream fout(versionFile);
-                    fout << latestMajor;
-                    log("Pinned major " + std::to_string(latestMajor) + " into version.txt");
-                } catch (...) {
-                }
-            }
-        }
-
-        std::string downloadUrl = pick_asset_url(channelJson, targetVersion);
-        if (downloadUrl.empty()) {
-            log("No asset found for version " + targetVersion);
-            return 1;
-        }
-
-        std::string host, path;
-        split_url(downloadUrl, host, path);
-
-        fs::path archivePath = archivesDir / fs::path(path).filename();
-        std::string baseName = fs::path(path).stem().stem().string();
-        fs::path extractDir = versionsDir / (targetVersion + "-" + baseName);
-        fs::path dotnetBin = extractDir / "dotnet";
- 
-
-        if (!fs::exists(archivePath)) {
-            log("Downloading " + path);
-            https_download(host, path, archivePath);
-        }
-        if (!fs::exists(dotnetBin)) {
-            fs::create_directories(extractDir);
-            if (!extract_tar_gz(archivePath.string(), extractDir.string())) {
-                log("Extraction failed");
+            Component c = make_component(downloadUrl, targetVersion, targetVersion,
+                                         archivesDir, versionsDir);
+            if (!provision_components({c}))
                 return 1;
-            }
+            extractDirs.push_back(c.extractDir);
         }
 
         for (auto &e : fs::directory_iterator(dotnetDir)) {
@@ -340,8 +711,9 @@ int main(int argc, char *argv[]) {
                 continue;
             fs::remove_all(e.path());
         }
-        for (auto &entry : fs::directory_iterator(extractDir))
-            fs::create_symlink(entry.path(), dotnetDir / entry.path().filename());
+        for (auto &dir : extractDirs)
+            merge_into_root(dir, dotnetDir);
+        install_muxer(dotnetDir);
 
         fs::path projectDotnetBin = dotnetDir / "dotnet";
         if (!fs::exists(projectDotnetBin)) {
@@ -388,10 +760,7 @@ int main(int argc, char *argv[]) {
         for (int i = dotnetArgStart; i < argc; i++)
             newArgs.push_back(argv[i]);
         newArgs.push_back(nullptr);
-        
-        std::cerr << "[debug] DOTNET_ROOT=" << getenv("DOTNET_ROOT") << "\n";
-        std::cerr << "[debug] PATH=" << getenv("PATH") << "\n";
-        
+
         return run_process(projectDotnetBin, newArgs.data(), "dotnet main") ? 0 : 1;
     } catch (const std::exception &e) {
         log(std::string("Error: ") + e.what());
@@ -1,7 +1,7 @@
 #include "extract_tar_gz.h"
+#include "log.h"
 #include <archive.h>
 #include <archive_entry.h>
-#include <iostream>
 #include <string>
 
 bool extract_tar_gz(const std::string& archivePath, const std::string& destDir) {
@@ -9,14 +9,14 @@ bool extract_tar_gz(const std::string& archivePath, const std::string& destDir)
     struct archive *ext;
     struct archive_entry *entry;
     int r;
+    bool ok = true;
 
     a = archive_read_new();
     archive_read_support_filter_gzip(a);   // 🔹 support .gz compression
     archive_read_support_format_tar(a);
 
     if ((r = archive_read_open_filename(a, archivePath.c_str(), 10240)) != ARCHIVE_OK) {
-        std::cerr << "archive_read_open_filename failed: "
-                  << archive_error_string(a) << "\n";
+        log(std::string("archive_read_open_filename failed: ") + archive_error_string(a));
         return false;
     }
 
@@ -30,7 +30,7 @@ bool extract_tar_gz(const std::string& archivePath, const std::string& destDir)
         r = archive_read_next_header(a, &entry);
         if (r == ARCHIVE_EOF) break;
         if (r < ARCHIVE_OK)
-            std::cerr << "Warning: " << archive_error_string(a) << "\n";
+            log(std::string("Warning: ") + archive_error_string(a));
         if (r < ARCHIVE_WARN) {
             archive_read_close(a);
             archive_read_free(a);
@@ -62,12 +62,19 @@ bool extract_tar_gz(const std::string& archivePath, const std::string& destDir)
                 if (r < ARCHIVE_OK) break;
             }
         }
-        archive_write_finish_entry(ext);
+        // a fatal read/write error (e.g. disk full) must not look like success
+        if (r < ARCHIVE_WARN || archive_write_finish_entry(ext) < ARCHIVE_WARN) {
+            const char *err = archive_error_string(ext);
+            if (!err) err = archive_error_string(a);
+            log("Extraction error on " + path + ": " + (err ? err : "unknown error"));
+            ok = false;
+            break;
+        }
     }
 
     archive_read_close(a);
     archive_read_free(a);
     archive_write_close(ext);
     archive_write_free(ext);
-    return true;
+    return ok;
 }
\ No newline at end of file
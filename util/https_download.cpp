@@ -1,4 +1,5 @@
 #include "https_download.h"
+#include "log.h"
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/ssl.hpp>
@@ -14,7 +15,6 @@
 #include <zlib.h>            // For quick gzip magic check
 
 #include <cstdlib>
-#include <iostream>
 #include <string>
 #include <fstream>
 
@@ -109,7 +109,7 @@ void https_download(const std::string& hostInit,
             auto loc = parser.get().base()["Location"];
             if (!loc.empty()) {
                 std::string locStr(loc);
-                std::cerr << "Redirect to: " << locStr << "\n";
+                log("Redirect to: " + locStr);
                 split_url(locStr, host, target);
                 continue; // retry
             }
@@ -126,7 +126,7 @@ void https_download(const std::string& hostInit,
                                      outFile.string());
         }
 
-        std::cerr << "Saved archive to " << outFile << " (gzip verified)\n";
+        log("Saved archive to " + outFile.string() + " (gzip verified)");
         return;
     }
 
@@ -0,0 +1,11 @@
+#include "log.h"
+#include <iostream>
+#include <mutex>
+
+static std::mutex logMutex;
+
+void log(const std::string& msg) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::cerr << msg << std::endl;
+    std::cerr.flush();
+}
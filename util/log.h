@@ -0,0 +1,9 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <string>
+
+// Thread-safe: writes one whole line to stderr under a lock.
+void log(const std::string& msg);
+
+#endif // LOG_H
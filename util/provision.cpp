@@ -0,0 +1,126 @@
+#include "provision.h"
+#include "https_download.h"
+#include "extract_tar_gz.h"
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// -------------------------------------------------------------------
+// Shared worker pool: every worker pulls the next job index until done
+// -------------------------------------------------------------------
+std::vector<std::string> run_parallel(size_t count, const std::function<void(size_t)>& job) {
+    std::vector<std::string> errors;
+    if (count == 0)
+        return errors;
+
+    // Downloads are I/O bound, so allow at least a few workers even on small machines
+    size_t workers = std::max<size_t>(4, std::thread::hardware_concurrency());
+    workers = std::min(workers, count);
+
+    std::atomic<size_t> next{0};
+    std::mutex errorsMutex;
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                job(i);
+            } catch (const std::exception &e) {
+                std::lock_guard<std::mutex> lock(errorsMutex);
+                errors.push_back(e.what());
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < workers; ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &t : threads)
+        t.join();
+
+    return errors;
+}
+
+// -------------------------------------------------------------------
+// Download + extract each component on the pool
+// -------------------------------------------------------------------
+bool provision_components(const std::vector<Component>& components) {
+    auto errors = run_parallel(components.size(), [&](size_t i) {
+        const Component &c = components[i];
+
+        if (!fs::exists(c.archivePath)) {
+            log("Downloading " + c.label + " from " + c.path);
+            // Download to a temp name so an interrupted run never leaves a truncated archive behind
+            fs::path partPath = c.archivePath;
+            partPath += ".part";
+            https_download(c.host, c.path, partPath);
+            fs::rename(partPath, c.archivePath);
+        }
+        if (!fs::exists(c.extractDir / "dotnet")) {
+            // Same idea for extraction: only a complete tree is renamed into place
+            fs::path partDir = c.extractDir;
+            partDir += ".part";
+            fs::remove_all(partDir);
+            fs::create_directories(partDir);
+            if (!extract_tar_gz(c.archivePath.string(), partDir.string())) {
+                fs::remove_all(partDir);
+                throw std::runtime_error("Extraction failed for " + c.label);
+            }
+            fs::remove_all(c.extractDir);
+            fs::rename(partDir, c.extractDir);
+        }
+        log("Ready: " + c.label);
+    });
+
+    for (auto &e : errors)
+        log("Error: " + e);
+    return errors.empty();
+}
+
+// -------------------------------------------------------------------
+// Symlink-merge srcDir into rootDir
+// -------------------------------------------------------------------
+void merge_into_root(const fs::path& srcDir, const fs::path& rootDir) {
+    for (auto &entry : fs::directory_iterator(srcDir)) {
+        fs::path target = rootDir / entry.path().filename();
+
+        if (!fs::exists(fs::symlink_status(target))) {
+            fs::create_symlink(entry.path(), target);
+            continue;
+        }
+        if (!entry.is_directory() || !fs::is_directory(target))
+            continue;
+
+        // Shared directory (host/fxr, shared/Microsoft.NETCore.App, ...):
+        // replace the symlink with a real directory holding both sides
+        if (fs::is_symlink(target)) {
+            fs::path previous = fs::read_symlink(target);
+            fs::remove(target);
+            fs::create_directory(target);
+            merge_into_root(previous, target);
+        }
+        merge_into_root(entry.path(), target);
+    }
+}
+
+// -------------------------------------------------------------------
+// Make rootDir/dotnet a real executable instead of a symlink
+// -------------------------------------------------------------------
+void install_muxer(const fs::path& rootDir) {
+    fs::path muxer = rootDir / "dotnet";
+    if (!fs::is_symlink(muxer))
+        return;
+
+    fs::path source = fs::read_symlink(muxer);
+    fs::remove(muxer);
+
+    std::error_code ec;
+    fs::create_hard_link(source, muxer, ec);
+    if (ec)
+        fs::copy_file(source, muxer);
+}
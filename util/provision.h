@@ -0,0 +1,36 @@
+#ifndef PROVISION_H
+#define PROVISION_H
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Component {
+    std::string label;      // e.g. "SDK 9.0.100", "runtime 8.0.11"
+    std::string host;
+    std::string path;
+    fs::path archivePath;
+    fs::path extractDir;
+};
+
+// Run job(0..count-1) on a shared pool of worker threads.
+// Returns the error message of every job that threw.
+std::vector<std::string> run_parallel(size_t count, const std::function<void(size_t)>& job);
+
+// Download and extract all components concurrently.
+bool provision_components(const std::vector<Component>& components);
+
+// Merge an extracted dotnet tree into a side-by-side root using symlinks.
+// Directories present in several components are expanded into real
+// directories; for conflicting files the first component merged wins.
+void merge_into_root(const fs::path& srcDir, const fs::path& rootDir);
+
+// Replace the rootDir/dotnet symlink with a real file (hardlink, or copy
+// across filesystems). The muxer resolves its root from its realpath, so
+// a symlink would make it ignore everything merged next to it.
+void install_muxer(const fs::path& rootDir);
+
+#endif // PROVISION_H